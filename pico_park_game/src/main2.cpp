@@ -4,10 +4,19 @@
 #include <thread>
 #include <chrono>    // For timer
 #include <atomic>    // For atomic variables
+#include <mutex>     // For the visibility change queue
+#include <algorithm> // For std::fill
 #include <cstdlib>   // For rand()
+#include <cstring>   // For strcmp()
 #include <windows.h> // For colored text in the console
 
 const int GRID_SIZE = 10;
+const int NUM_PLAYERS = 2;
+const int VIEW_RADIUS = 4;          // How far each player can see
+const int VISIBILITY_BUDGET = 2048; // Max cells scanned by the visibility pass per tick
+const int FRAME_INTERVAL_MS = 50;   // How often a frame is published when no key was pressed
+const int FRAME_POLL_MS = 5;        // How long the render thread sleeps when no new frame is ready
+const int FRAME_READY = 4;          // Set on the shared triple buffer slot until the renderer takes it
 
 // Color constants
 #define COLOR_GREEN 10
@@ -16,6 +25,50 @@ const int GRID_SIZE = 10;
 #define COLOR_MAGENTA 13
 #define COLOR_CYAN 11
 #define COLOR_DEFAULT 7
+#define COLOR_DIM 8
+
+// One player's field of view, stored as a mask over the square window around the cell it was cast from
+struct FieldOfView
+{
+    int originX = -1, originY = -1; // Where the player is now
+    int castX = -1, castY = -1;     // Where the mask was last computed
+    std::vector<char> mask;         // (2 * VIEW_RADIUS + 1)^2 cells: 0 = not scanned, 1 = scanned, 2 = visible
+    bool dirty = true;
+};
+
+// Union of all players' views plus remembered terrain (fog of war)
+struct Visibility
+{
+    int width = 0, height = 0;
+    std::vector<unsigned short> seenBy; // Number of players currently seeing each cell
+    std::vector<char> remembered;       // Last terrain seen in each cell, 0 if never seen
+    std::vector<FieldOfView> views;
+    size_t nextView = 0; // Round-robin start so views deferred by the budget are not starved
+    std::mutex changesMutex;
+    std::vector<std::pair<int, int>> changedCells; // Blocking cells that changed since the last pass
+};
+
+// Everything the renderer needs for one frame, copied out of the simulation
+struct FrameSnapshot
+{
+    int width = 0, height = 0;
+    std::vector<char> cells;  // Character drawn in each cell, ' ' if unexplored
+    std::vector<char> dimmed; // 1 if the cell is remembered rather than currently visible
+    int level = 0, timeLeft = 0, movesP1 = 0, movesP2 = 0, score = 0;
+};
+
+// Lock-free triple buffer: the simulation writes into its back slot and swaps it with the shared
+// middle slot; the renderer swaps the middle slot into its front slot. Neither side ever waits.
+struct FrameBuffer
+{
+    FrameSnapshot slots[3];
+    int backIndex = 0;             // Only touched by the simulation
+    int frontIndex = 1;            // Only touched by the renderer
+    std::atomic<int> middle{2};    // Index of the shared slot, plus FRAME_READY while unread
+    long long framesPublished = 0; // Simulation-side counters, read once the game is over
+    long long framesDropped = 0;   // Published but replaced before the renderer took them
+    long long publishNanos = 0;    // Total time spent building and publishing snapshots
+};
 
 void setColor(int color)
 {
@@ -23,40 +76,52 @@ void setColor(int color)
     SetConsoleTextAttribute(hConsole, color);
 }
 
-void renderGrid(const std::vector<std::vector<char>> &grid, int timeLeft, int movesP1, int movesP2, int score, int level)
+void setCellColor(char cell)
+{
+    switch (cell)
+    {
+    case 'P':
+        setColor(COLOR_GREEN);
+        break; // Player 1
+    case '2':
+        setColor(COLOR_CYAN);
+        break; // Player 2
+    case 'G':
+        setColor(COLOR_YELLOW);
+        break; // Goal
+    case 'X':
+        setColor(COLOR_RED);
+        break; // Obstacles
+    case 'C':
+        setColor(COLOR_CYAN);
+        break; // Collectibles
+    case 'T':
+        setColor(COLOR_MAGENTA);
+        break; // Traps
+    default:
+        setColor(COLOR_DEFAULT);
+        break; // Default (empty spaces)
+    }
+}
+
+// Only cells a player can see are drawn live; remembered cells are drawn dimmed, the rest stays dark
+void renderGrid(const FrameSnapshot &frame)
 {
     system("cls"); // Clear the screen
-    std::cout << "Level: " << level << " | Time Remaining: " << timeLeft << " seconds"
-              << " | P1 Moves: " << movesP1 << " | P2 Moves: " << movesP2 << " | Score: " << score << std::endl;
+    std::cout << "Level: " << frame.level << " | Time Remaining: " << frame.timeLeft << " seconds"
+              << " | P1 Moves: " << frame.movesP1 << " | P2 Moves: " << frame.movesP2
+              << " | Score: " << frame.score << std::endl;
 
-    for (const auto &row : grid)
+    for (int y = 0; y < frame.height; y++)
     {
-        for (const auto &cell : row)
+        for (int x = 0; x < frame.width; x++)
         {
-            switch (cell)
-            {
-            case 'P':
-                setColor(COLOR_GREEN);
-                break; // Player 1
-            case '2':
-                setColor(COLOR_CYAN);
-                break; // Player 2
-            case 'G':
-                setColor(COLOR_YELLOW);
-                break; // Goal
-            case 'X':
-                setColor(COLOR_RED);
-                break; // Obstacles
-            case 'C':
-                setColor(COLOR_CYAN);
-                break; // Collectibles
-            case 'T':
-                setColor(COLOR_MAGENTA);
-                break; // Traps
-            default:
-                setColor(COLOR_DEFAULT);
-                break; // Default (empty spaces)
-            }
+            size_t index = (size_t)y * frame.width + x;
+            char cell = frame.cells[index];
+            if (frame.dimmed[index])
+                setColor(COLOR_DIM);
+            else
+                setCellColor(cell);
             std::cout << cell << " ";
         }
         setColor(COLOR_DEFAULT); // Reset color after each row
@@ -64,6 +129,254 @@ void renderGrid(const std::vector<std::vector<char>> &grid, int timeLeft, int mo
     }
 }
 
+// Copies the visible board and HUD into the back slot and hands it to the renderer
+void publishFrame(FrameBuffer &frames, const std::vector<std::vector<char>> &grid, const Visibility &vis,
+                  int level, int timeLeft, int movesP1, int movesP2, int score)
+{
+    auto start = std::chrono::steady_clock::now();
+    FrameSnapshot &frame = frames.slots[frames.backIndex];
+
+    frame.width = vis.width;
+    frame.height = vis.height;
+    frame.cells.resize((size_t)vis.width * vis.height);
+    frame.dimmed.resize((size_t)vis.width * vis.height);
+    for (int y = 0; y < vis.height; y++)
+    {
+        for (int x = 0; x < vis.width; x++)
+        {
+            size_t index = (size_t)y * vis.width + x;
+            if (vis.seenBy[index] > 0)
+            {
+                frame.cells[index] = grid[y][x];
+                frame.dimmed[index] = 0;
+            }
+            else
+            {
+                frame.cells[index] = vis.remembered[index] != 0 ? vis.remembered[index] : ' ';
+                frame.dimmed[index] = 1;
+            }
+        }
+    }
+    frame.level = level;
+    frame.timeLeft = timeLeft;
+    frame.movesP1 = movesP1;
+    frame.movesP2 = movesP2;
+    frame.score = score;
+
+    int previous = frames.middle.exchange(frames.backIndex | FRAME_READY, std::memory_order_acq_rel);
+    if (previous & FRAME_READY)
+        frames.framesDropped++;
+    frames.backIndex = previous & ~FRAME_READY;
+    frames.framesPublished++;
+    frames.publishNanos +=
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Returns the latest published frame, or nullptr if nothing new arrived since the last call
+const FrameSnapshot *consumeFrame(FrameBuffer &frames)
+{
+    if (!(frames.middle.load(std::memory_order_acquire) & FRAME_READY))
+        return nullptr;
+    int previous = frames.middle.exchange(frames.frontIndex, std::memory_order_acq_rel);
+    frames.frontIndex = previous & ~FRAME_READY;
+    return &frames.slots[frames.frontIndex];
+}
+
+void renderThread(FrameBuffer &frames, std::atomic<bool> &gameRunning)
+{
+    while (gameRunning)
+    {
+        const FrameSnapshot *frame = consumeFrame(frames);
+        if (frame)
+            renderGrid(*frame);
+        else
+            std::this_thread::sleep_for(std::chrono::milliseconds(FRAME_POLL_MS));
+    }
+}
+
+void resetVisibility(Visibility &vis, int width, int height, int numPlayers)
+{
+    vis.width = width;
+    vis.height = height;
+    vis.seenBy.assign((size_t)width * height, 0);
+    vis.remembered.assign((size_t)width * height, 0);
+    vis.views.assign(numPlayers, FieldOfView());
+    vis.nextView = 0;
+
+    std::lock_guard<std::mutex> lock(vis.changesMutex);
+    vis.changedCells.clear();
+}
+
+void movePlayerView(Visibility &vis, int player, int x, int y)
+{
+    FieldOfView &view = vis.views[player];
+    if (view.originX != x || view.originY != y)
+    {
+        view.originX = x;
+        view.originY = y;
+        view.dirty = true;
+    }
+}
+
+// Called by the obstacle threads whenever a blocking cell appears or disappears
+void noteBlockerChanged(Visibility &vis, int x, int y)
+{
+    std::lock_guard<std::mutex> lock(vis.changesMutex);
+    vis.changedCells.push_back({x, y});
+}
+
+// True if the view read this cell while casting, i.e. a blocker change there can alter the view
+bool viewDependsOn(const FieldOfView &view, int x, int y)
+{
+    const int side = 2 * VIEW_RADIUS + 1;
+    int dx = x - view.castX + VIEW_RADIUS;
+    int dy = y - view.castY + VIEW_RADIUS;
+    if (view.mask.empty() || dx < 0 || dx >= side || dy < 0 || dy >= side)
+        return false;
+    return view.mask[dy * side + dx] != 0;
+}
+
+// Recursive shadowcasting over one octant; xx, xy, yx, yy map octant offsets onto the grid
+void castLight(const std::vector<std::vector<char>> &grid, FieldOfView &view, int &work, int row, double start,
+               double end, int xx, int xy, int yx, int yy)
+{
+    if (start < end)
+        return;
+
+    const int side = 2 * VIEW_RADIUS + 1;
+    const int height = grid.size();
+    const int width = grid[0].size();
+    double newStart = 0.0;
+
+    for (int j = row; j <= VIEW_RADIUS; j++)
+    {
+        bool blocked = false;
+        int dy = -j;
+        for (int dx = -j; dx <= 0; dx++)
+        {
+            double leftSlope = (dx - 0.5) / (dy + 0.5);
+            double rightSlope = (dx + 0.5) / (dy - 0.5);
+            if (start < rightSlope)
+                continue;
+            if (end > leftSlope)
+                break;
+
+            int mapX = view.castX + dx * xx + dy * xy;
+            int mapY = view.castY + dx * yx + dy * yy;
+            bool inside = mapX >= 0 && mapX < width && mapY >= 0 && mapY < height;
+            work++;
+
+            if (inside)
+            {
+                char &seen = view.mask[(mapY - view.castY + VIEW_RADIUS) * side + (mapX - view.castX + VIEW_RADIUS)];
+                if (dx * dx + dy * dy <= VIEW_RADIUS * VIEW_RADIUS)
+                    seen = 2;
+                else if (seen == 0)
+                    seen = 1;
+            }
+
+            bool wall = !inside || grid[mapY][mapX] == 'X'; // The map edge blocks sight like an obstacle
+            if (blocked)
+            {
+                if (wall)
+                {
+                    newStart = rightSlope;
+                    continue;
+                }
+                blocked = false;
+                start = newStart;
+            }
+            else if (wall && j < VIEW_RADIUS)
+            {
+                blocked = true;
+                castLight(grid, view, work, j + 1, start, leftSlope, xx, xy, yx, yy);
+                newStart = rightSlope;
+            }
+        }
+        if (blocked)
+            break;
+    }
+}
+
+void computeView(const std::vector<std::vector<char>> &grid, FieldOfView &view, int &work)
+{
+    static const int octants[4][8] = {{1, 0, 0, -1, -1, 0, 0, 1},
+                                      {0, 1, -1, 0, 0, -1, 1, 0},
+                                      {0, 1, 1, 0, 0, -1, -1, 0},
+                                      {1, 0, 0, 1, -1, 0, 0, -1}};
+    const int side = 2 * VIEW_RADIUS + 1;
+
+    view.mask.resize(side * side);
+    std::fill(view.mask.begin(), view.mask.end(), 0);
+    view.mask[VIEW_RADIUS * side + VIEW_RADIUS] = 2; // A player always sees its own cell
+
+    for (int oct = 0; oct < 8; oct++)
+    {
+        castLight(grid, view, work, 1, 1.0, 0.0, octants[0][oct], octants[1][oct], octants[2][oct],
+                  octants[3][oct]);
+    }
+}
+
+// Adds (delta = 1) or removes (delta = -1) one view's cells from the shared counts
+void applyView(Visibility &vis, const std::vector<std::vector<char>> &grid, const FieldOfView &view, int delta)
+{
+    const int side = 2 * VIEW_RADIUS + 1;
+    for (size_t i = 0; i < view.mask.size(); i++)
+    {
+        if (view.mask[i] != 2)
+            continue;
+        int x = view.castX + (int)(i % side) - VIEW_RADIUS;
+        int y = view.castY + (int)(i / side) - VIEW_RADIUS;
+        size_t index = (size_t)y * vis.width + x;
+        vis.seenBy[index] += delta;
+        if (delta > 0)
+        {
+            char cell = grid[y][x];
+            vis.remembered[index] = (cell == 'P' || cell == '2') ? '.' : cell; // Players are not terrain
+        }
+    }
+}
+
+// Recomputes only the views touched by a player move or a blocker change since the last pass.
+// Views that do not fit in the budget keep their old mask and are picked up first next tick.
+void updateVisibility(Visibility &vis, const std::vector<std::vector<char>> &grid, int budget)
+{
+    std::vector<std::pair<int, int>> changes;
+    {
+        std::lock_guard<std::mutex> lock(vis.changesMutex);
+        changes.swap(vis.changedCells);
+    }
+
+    // A blocker only changes a view if the cast looked at its old or new cell
+    for (const auto &cell : changes)
+    {
+        for (auto &view : vis.views)
+        {
+            if (!view.dirty && viewDependsOn(view, cell.first, cell.second))
+                view.dirty = true;
+        }
+    }
+
+    int work = 0;
+    size_t count = vis.views.size();
+    size_t first = vis.nextView;
+    for (size_t i = 0; i < count && work < budget; i++)
+    {
+        size_t current = (first + i) % count;
+        FieldOfView &view = vis.views[current];
+        if (!view.dirty || view.originX < 0)
+            continue;
+
+        applyView(vis, grid, view, -1);
+        view.castX = view.originX;
+        view.castY = view.originY;
+        computeView(grid, view, work);
+        applyView(vis, grid, view, 1);
+        view.dirty = false;
+        vis.nextView = (current + 1) % count;
+    }
+}
+
 void timerThread(std::atomic<int> &timeLeft, std::atomic<bool> &gameRunning)
 {
     while (timeLeft > 0 && gameRunning)
@@ -75,7 +388,8 @@ void timerThread(std::atomic<int> &timeLeft, std::atomic<bool> &gameRunning)
 }
 
 void chasingObstacleThread(std::vector<std::pair<int, int>> &obstacles, std::vector<std::vector<char>> &grid,
-                           std::atomic<bool> &gameRunning, int &player1X, int &player1Y, int &player2X, int &player2Y)
+                           Visibility &vis, std::atomic<bool> &gameRunning, int &player1X, int &player1Y,
+                           int &player2X, int &player2Y)
 {
     while (gameRunning)
     {
@@ -101,6 +415,8 @@ void chasingObstacleThread(std::vector<std::pair<int, int>> &obstacles, std::vec
             {
                 grid[oldY][oldX] = '.';
                 grid[newY][newX] = 'X';
+                noteBlockerChanged(vis, oldX, oldY);
+                noteBlockerChanged(vis, newX, newY);
                 obstacle = {newX, newY};
             }
         }
@@ -108,7 +424,7 @@ void chasingObstacleThread(std::vector<std::pair<int, int>> &obstacles, std::vec
 }
 
 void patrollingObstacleThread(std::vector<std::pair<int, int>> &obstacles, std::vector<std::vector<char>> &grid,
-                              std::atomic<bool> &gameRunning)
+                              Visibility &vis, std::atomic<bool> &gameRunning)
 {
     std::vector<int> directions(obstacles.size(), 0);
 
@@ -135,6 +451,8 @@ void patrollingObstacleThread(std::vector<std::pair<int, int>> &obstacles, std::
             {
                 grid[oldY][oldX] = '.';
                 grid[newY][newX] = 'X';
+                noteBlockerChanged(vis, oldX, oldY);
+                noteBlockerChanged(vis, newX, newY);
                 obstacles[i] = {newX, newY};
             }
             else
@@ -283,8 +601,10 @@ bool updatePlayerPosition(char direction, int &playerX, int &playerY, std::vecto
     return false;
 }
 
-int main()
+// Pass --headless to run the simulation without the render thread, e.g. to measure publish cost
+int main(int argc, char *argv[])
 {
+    bool headless = argc > 1 && strcmp(argv[1], "--headless") == 0;
     std::atomic<int> timeLeft(30);
     std::atomic<bool> gameRunning(true);
     int player1X = 1, player1Y = 1, player2X = GRID_SIZE - 2, player2Y = 1;
@@ -292,17 +612,27 @@ int main()
     int movesP1 = 0, movesP2 = 0, score = 0, level = 1;
     std::vector<std::vector<char>> grid(GRID_SIZE, std::vector<char>(GRID_SIZE, '.'));
     std::vector<std::pair<int, int>> chasingObstacles, patrollingObstacles, collectibles, traps;
+    Visibility vis;
+    FrameBuffer frames;
 
     setupLevel(level, grid, chasingObstacles, patrollingObstacles, collectibles, traps, timeLeft,
                player1X, player1Y, player2X, player2Y, goalX, goalY);
+    resetVisibility(vis, GRID_SIZE, GRID_SIZE, NUM_PLAYERS);
+    movePlayerView(vis, 0, player1X, player1Y);
+    movePlayerView(vis, 1, player2X, player2Y);
+    updateVisibility(vis, grid, VISIBILITY_BUDGET);
 
     std::thread timer(timerThread, std::ref(timeLeft), std::ref(gameRunning));
-    std::thread chasingThread(chasingObstacleThread, std::ref(chasingObstacles), std::ref(grid),
+    std::thread chasingThread(chasingObstacleThread, std::ref(chasingObstacles), std::ref(grid), std::ref(vis),
                               std::ref(gameRunning), std::ref(player1X), std::ref(player1Y), std::ref(player2X), std::ref(player2Y));
     std::thread patrollingThread(patrollingObstacleThread, std::ref(patrollingObstacles), std::ref(grid),
-                                 std::ref(gameRunning));
+                                 std::ref(vis), std::ref(gameRunning));
 
-    renderGrid(grid, timeLeft, movesP1, movesP2, score, level);
+    publishFrame(frames, grid, vis, level, timeLeft, movesP1, movesP2, score);
+    auto lastPublish = std::chrono::steady_clock::now();
+    std::thread render;
+    if (!headless)
+        render = std::thread(renderThread, std::ref(frames), std::ref(gameRunning));
 
     while (gameRunning)
     {
@@ -329,16 +659,34 @@ int main()
                 level++;
                 setupLevel(level, grid, chasingObstacles, patrollingObstacles, collectibles, traps, timeLeft,
                            player1X, player1Y, player2X, player2Y, goalX, goalY);
+                resetVisibility(vis, GRID_SIZE, GRID_SIZE, NUM_PLAYERS);
                 movesP1 = movesP2 = 0;
             }
-            renderGrid(grid, timeLeft, movesP1, movesP2, score, level);
+            movePlayerView(vis, 0, player1X, player1Y);
+            movePlayerView(vis, 1, player2X, player2Y);
+            updateVisibility(vis, grid, VISIBILITY_BUDGET);
+            publishFrame(frames, grid, vis, level, timeLeft, movesP1, movesP2, score);
+            lastPublish = std::chrono::steady_clock::now();
+        }
+        else
+        {
+            updateVisibility(vis, grid, VISIBILITY_BUDGET); // Keep up with obstacle moves between keypresses
+            if (std::chrono::steady_clock::now() - lastPublish >= std::chrono::milliseconds(FRAME_INTERVAL_MS))
+            {
+                publishFrame(frames, grid, vis, level, timeLeft, movesP1, movesP2, score);
+                lastPublish = std::chrono::steady_clock::now();
+            }
         }
     }
 
     timer.join();
     chasingThread.join();
     patrollingThread.join();
+    if (render.joinable())
+        render.join();
 
     std::cout << "Game Over! Final Score: " << score << std::endl;
+    std::cout << "Frames published: " << frames.framesPublished << " | Dropped: " << frames.framesDropped
+              << " | Avg publish: " << frames.publishNanos / (frames.framesPublished * 1000.0) << " us" << std::endl;
     return 0;
 }